@@ -23,6 +23,7 @@ if __name__ == '__main__':
 
     if cwd != sd:
         shutil.copyfile(sd.joinpath('main.py'), cwd.joinpath('main.py'))
+        shutil.copyfile(sd.joinpath('subscriber_registry.py'), cwd.joinpath('subscriber_registry.py'))
         shutil.copyfile(sd.joinpath('requirements.txt'), cwd.joinpath('requirements.txt'))
 
     env_builder = venv.EnvBuilder(clear=True, symlinks=False, system_site_packages=False, with_pip=True)
@@ -10,10 +10,11 @@ import sys
 import signal
 import stat
 import struct
+from subscriber_registry import SubscriberRegistry
 import threading
 import time
 
-subscriber_list = set()
+subscriber_list = SubscriberRegistry()
 is_verbose = False
 
 def show_threads():
@@ -92,16 +93,14 @@ class AltShiftNotify(threading.Thread):
 def send_notification():
     if is_verbose:
         print('Alt+Shift detected')
-    subscribers = list(subscriber_list)
-    for pid in subscribers:
+    for pid in subscriber_list.snapshot():
         if is_verbose:
             print(f'Sending SIGUSR1 to {pid}')
         try:
             os.kill(pid, signal.SIGUSR1)
         except ProcessLookupError:
-            if is_verbose:
+            if subscriber_list.discard(pid) and is_verbose:
                 print(f'Removing missing subscriber: {pid}')
-            subscriber_list.remove(pid)
 
 def enumate_keyboard_event_devices(context: pyudev.Context):
     devices = []
@@ -229,6 +228,6 @@ if __name__ == '__main__':
         elif received.si_signo == signal.SIGUSR2:
             if is_verbose:
                 print(f'Removing subscriber: {received.si_pid}')
-            subscriber_list.remove(received.si_pid)
+            subscriber_list.discard(received.si_pid)
         elif received.si_signo == signal.SIGTERM or received.si_signo == signal.SIGINT:
             sys.exit(0)
@@ -0,0 +1,28 @@
+import threading
+
+
+class SubscriberRegistry:
+    """
+    Set of subscribed PIDs published as an immutable snapshot.
+
+    Readers take the current frozenset without locking; writers build a new
+    snapshot under a lock and replace the reference, which is atomic.
+    """
+    def __init__(self):
+        self.__snapshot = frozenset()
+        self.__write_lock = threading.Lock()
+
+    def snapshot(self) -> frozenset:
+        return self.__snapshot
+
+    def add(self, pid: int):
+        with self.__write_lock:
+            if pid not in self.__snapshot:
+                self.__snapshot = self.__snapshot | {pid}
+
+    def discard(self, pid: int) -> bool:
+        with self.__write_lock:
+            if pid not in self.__snapshot:
+                return False
+            self.__snapshot = self.__snapshot - {pid}
+            return True
@@ -0,0 +1,82 @@
+import threading
+import unittest
+
+from subscriber_registry import SubscriberRegistry
+
+
+class SubscriberRegistryTest(unittest.TestCase):
+    def test_add_discard(self):
+        registry = SubscriberRegistry()
+        registry.add(1)
+        registry.add(1)
+        self.assertEqual(registry.snapshot(), frozenset({1}))
+        self.assertTrue(registry.discard(1))
+        self.assertFalse(registry.discard(1))
+        self.assertEqual(registry.snapshot(), frozenset())
+
+    def test_snapshot_is_immutable(self):
+        registry = SubscriberRegistry()
+        registry.add(1)
+        snapshot = registry.snapshot()
+        registry.add(2)
+        registry.discard(1)
+        self.assertEqual(snapshot, frozenset({1}))
+        self.assertEqual(registry.snapshot(), frozenset({2}))
+
+    def test_concurrent_subscribe_unsubscribe_toggle(self):
+        registry = SubscriberRegistry()
+        stable = range(0, 100)
+        churn = range(1000, 1100)
+        dead = range(2000, 2050)
+        for pid in dead:
+            registry.add(pid)
+
+        rounds = 200
+        toggle_threads = 4
+        errors = []
+        removed = []
+        removed_lock = threading.Lock()
+        barrier = threading.Barrier(2 + toggle_threads)
+
+        def guarded(target):
+            def run():
+                try:
+                    barrier.wait()
+                    target()
+                except BaseException as e:
+                    errors.append(e)
+            return run
+
+        def subscribe():
+            for pid in stable:
+                registry.add(pid)
+
+        def unsubscribe():
+            for _ in range(rounds):
+                for pid in churn:
+                    registry.add(pid)
+                for pid in churn:
+                    registry.discard(pid)
+
+        def toggle():
+            # Mirrors send_notification(): iterate the snapshot and drop subscribers that are gone.
+            for _ in range(rounds):
+                for pid in registry.snapshot():
+                    if pid in dead and registry.discard(pid):
+                        with removed_lock:
+                            removed.append(pid)
+
+        threads = [threading.Thread(target=guarded(subscribe)), threading.Thread(target=guarded(unsubscribe))]
+        threads += [threading.Thread(target=guarded(toggle)) for _ in range(toggle_threads)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        self.assertEqual(errors, [])
+        self.assertEqual(registry.snapshot(), frozenset(stable))
+        self.assertEqual(sorted(removed), list(dead))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <cstdlib>
 #include <dirent.h>
 #include <errno.h>
@@ -5,6 +6,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <list>
 #include <map>
 #include <mutex>
 #include <optional>
@@ -15,8 +17,12 @@
 #include <sys/inotify.h>
 #include <thread>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
+#include <X11/Xatom.h>
 #include <X11/XKBlib.h>
+#include <X11/Xproto.h>
+#include <X11/Xutil.h>
 
 namespace fs = std::filesystem;
 
@@ -25,8 +31,10 @@ public:
     bool forking;
     std::string pidFile;
     std::string display;
+    std::string remember;
+    std::size_t rememberSize;
 
-    Settings() : forking{ false }, pidFile("/var/run/alt-shift-notify/service.pid"), display("") {}
+    Settings() : forking{ false }, pidFile("/var/run/alt-shift-notify/service.pid"), display(""), remember(""), rememberSize(256) {}
 };
 
 void showHelp(int argc, char* argv[]) {
@@ -39,6 +47,9 @@ void showHelp(int argc, char* argv[]) {
     std::cerr << "                        to subscribe to." << std::endl;
     std::cerr << "  --display <string>    [default=\"\"] Specify the displayto connect to." << std::endl;
     std::cerr << "                        Defaults to connecting to the main display." << std::endl;
+    std::cerr << "  --remember <mode>     Remember the keyboard layout per \"window\" or per" << std::endl;
+    std::cerr << "                        \"class\" (WM_CLASS) and restore it on focus change." << std::endl;
+    std::cerr << "  --remember-size <n>   [default=256] Maximum number of remembered layouts." << std::endl;
     std::cerr << std::endl;
     std::cerr << "The process specified in the PID file will receive SIGUSR1. That signal should" << std::endl;
     std::cerr << "be interpted as \"subscribe\". If possible, when terminating, SIGUSR2 will be" << std::endl;
@@ -80,6 +91,9 @@ public:
         XCloseDisplay(m_display);
     }
 public:
+    Display* display() const {
+        return m_display;
+    }
     std::vector<std::pair<int, std::string>> groups() const {
         std::vector<std::pair<int, std::string>> groups;
         XkbDescPtr kb = XkbAllocKeyboard();
@@ -126,6 +140,253 @@ public:
     }
 };
 
+/**
+ * @brief Fixed capacity map evicting the least recently used entry.
+ *
+ * Both lookup and insertion are O(1): the list keeps the usage order and
+ * the hash map points into the list.
+ */
+template<typename K, typename V>
+class lru_cache {
+    using entry = std::pair<K, V>;
+    std::size_t m_capacity;
+    std::list<entry> m_order;
+    std::unordered_map<K, typename std::list<entry>::iterator> m_index;
+public:
+    explicit lru_cache(std::size_t capacity) : m_capacity(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("lru_cache capacity must be positive");
+        }
+    }
+
+    std::optional<V> get(const K& key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            return std::nullopt;
+        }
+        m_order.splice(m_order.begin(), m_order, it->second);
+        return it->second->second;
+    }
+
+    /**
+     * @brief Insert or update the value for a key.
+     *
+     * @return The key evicted to make room for the new entry, if any.
+     */
+    std::optional<K> put(const K& key, const V& value) {
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            it->second->second = value;
+            m_order.splice(m_order.begin(), m_order, it->second);
+            return std::nullopt;
+        }
+        std::optional<K> evicted;
+        if (m_order.size() >= m_capacity) {
+            evicted = m_order.back().first;
+            m_index.erase(m_order.back().first);
+            m_order.pop_back();
+        }
+        m_order.emplace_front(key, value);
+        m_index[key] = m_order.begin();
+        return evicted;
+    }
+
+    bool erase(const K& key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            return false;
+        }
+        m_order.erase(it->second);
+        m_index.erase(it);
+        return true;
+    }
+
+    std::size_t size() const {
+        return m_order.size();
+    }
+};
+
+XErrorHandler previous_error_handler = nullptr;
+
+/**
+ * @brief Ignore BadWindow from the requests issued on watched windows.
+ *
+ * A watched window may be destroyed at any time before we query or stop watching it.
+ * Any other error is forwarded to the previous (by default fatal) handler.
+ */
+int ignore_watched_window_error(Display* display, XErrorEvent* event) {
+    if (event->error_code == BadWindow) {
+        switch (event->request_code) {
+        case X_ChangeWindowAttributes:
+        case X_GetWindowAttributes:
+        case X_GetGeometry:
+        case X_GetProperty:
+            return 0;
+        }
+    }
+    if (previous_error_handler != nullptr) {
+        return previous_error_handler(display, event);
+    }
+    return 0;
+}
+
+/**
+ * @brief Restores the keyboard layout last used in a window when it gets focus.
+ *
+ * Observes _NET_ACTIVE_WINDOW on the root window. When the focus changes, the current
+ * group is stored for the window losing the focus and the group stored for the window
+ * receiving the focus (if any) is locked. In "window" mode the layouts are keyed by
+ * window id and destroyed windows (including the focused one) are evicted; in "class" mode they are keyed by the
+ * WM_CLASS class name. Either way the number of entries is bounded.
+ */
+class active_window_layout_memory {
+    XkbConnection& connection;
+    Display* display;
+    Window root;
+    Atom net_active_window;
+    bool by_class;
+    Window active;
+    std::optional<std::string> active_class;
+    lru_cache<Window, int> window_groups;
+    lru_cache<std::string, int> class_groups;
+
+public:
+    explicit active_window_layout_memory(XkbConnection& connection, bool by_class, std::size_t capacity) :
+        connection(connection),
+        display(connection.display()),
+        root(DefaultRootWindow(connection.display())),
+        net_active_window(XInternAtom(connection.display(), "_NET_ACTIVE_WINDOW", False)),
+        by_class(by_class),
+        active(None),
+        active_class(std::nullopt),
+        window_groups(capacity),
+        class_groups(capacity) {
+        previous_error_handler = XSetErrorHandler(ignore_watched_window_error);
+        XSelectInput(display, root, PropertyChangeMask);
+        activate(active_window());
+        XFlush(display);
+    }
+
+    void run() {
+        while (1) {
+            XEvent event;
+            XNextEvent(display, &event);
+            if (event.type == PropertyNotify && event.xproperty.window == root && event.xproperty.atom == net_active_window) {
+                on_active_window_change(active_window());
+            } else if (event.type == DestroyNotify) {
+                forget(event.xdestroywindow.window);
+            }
+        }
+    }
+
+private:
+    Window active_window() {
+        Atom type;
+        int format;
+        unsigned long count;
+        unsigned long remaining;
+        unsigned char* data = nullptr;
+        Window window = None;
+        auto status = XGetWindowProperty(display, root, net_active_window, 0, 1, False, XA_WINDOW, &type, &format, &count, &remaining, &data);
+        if (status == Success && data != nullptr) {
+            if (type == XA_WINDOW && format == 32 && count > 0) {
+                window = *reinterpret_cast<Window*>(data);
+            }
+            XFree(data);
+        }
+        return window;
+    }
+
+    std::optional<std::string> window_class(Window window) {
+        XClassHint hint;
+        if (!XGetClassHint(display, window, &hint)) {
+            return std::nullopt;
+        }
+        std::optional<std::string> name;
+        if (hint.res_class != nullptr) {
+            name = std::string(hint.res_class);
+        }
+        XFree(hint.res_name);
+        XFree(hint.res_class);
+        return name;
+    }
+
+    void on_active_window_change(Window window) {
+        if (window == active) {
+            return;
+        }
+        auto group = connection.groupIndex();
+        if (active != None) {
+            store(group);
+        }
+        activate(window);
+        if (active == None) {
+            return;
+        }
+        auto stored = load();
+        if (stored && *stored != group) {
+            std::cout << "Restoring keyboard layout " << *stored << " for window " << active << std::endl;
+            connection.groupIndex(*stored);
+        }
+    }
+
+    /**
+     * @brief Track the window receiving the focus.
+     *
+     * Everything needed to store the layout later is taken now, while the window exists:
+     * in "window" mode we subscribe to its DestroyNotify (and check it was not destroyed
+     * before the subscription took effect), in "class" mode we cache its WM_CLASS.
+     */
+    void activate(Window window) {
+        active = window;
+        active_class = std::nullopt;
+        if (window == None) {
+            return;
+        }
+        if (by_class) {
+            active_class = window_class(window);
+            return;
+        }
+        XSelectInput(display, window, StructureNotifyMask);
+        XWindowAttributes attributes;
+        if (!XGetWindowAttributes(display, window, &attributes)) {
+            forget(window);
+        }
+    }
+
+    std::optional<int> load() {
+        if (by_class) {
+            return active_class ? class_groups.get(*active_class) : std::nullopt;
+        }
+        return window_groups.get(active);
+    }
+
+    void store(int group) {
+        if (by_class) {
+            if (active_class) {
+                class_groups.put(*active_class, group);
+            }
+            return;
+        }
+        auto evicted = window_groups.put(active, group);
+        if (evicted) {
+            XSelectInput(display, *evicted, NoEventMask);
+            XFlush(display);
+        }
+    }
+
+    void forget(Window window) {
+        window_groups.erase(window);
+        if (window == active) {
+            active = None;
+        }
+    }
+};
+
+void active_window_thread(active_window_layout_memory* memory) {
+    memory->run();
+}
+
 XkbConnection* connection = nullptr;
 
 class errno_runtime_error : public std::runtime_error {
@@ -376,6 +637,35 @@ int main(int argc, char* argv[]) {
             } else {
                 settings.display = argv[++i];
             }
+        } else if (arg == "--remember" || arg == "-r") {
+            if (i + 1 >= argc) {
+                errorMessage = "Missing remember argument attribute";
+            } else {
+                settings.remember = argv[++i];
+                if (settings.remember != "window" && settings.remember != "class") {
+                    errorMessage = "Invalid remember mode: " + settings.remember;
+                }
+            }
+        } else if (arg == "--remember-size") {
+            if (i + 1 >= argc) {
+                errorMessage = "Missing remember-size argument attribute";
+            } else {
+                std::string value = argv[++i];
+                std::size_t parsed = 0;
+                unsigned long size = 0;
+                if (!value.empty() && isdigit(static_cast<unsigned char>(value[0]))) {
+                    try {
+                        size = std::stoul(value, &parsed);
+                    } catch (const std::out_of_range& e) {
+                        parsed = 0;
+                    }
+                }
+                if (parsed != value.size() || size == 0) {
+                    errorMessage = "Invalid remember-size: " + value;
+                } else {
+                    settings.rememberSize = size;
+                }
+            }
         } else {
             errorMessage = std::string("Unknown argument: ") + argv[i];
         }
@@ -405,6 +695,14 @@ int main(int argc, char* argv[]) {
     std::cout << "PID File: " << pidFilePath << std::endl;
     std::thread pid_watcher_thread(observer_pid_file_thread, pidFilePath);
     pid_watcher_thread.detach();
+    if (!settings.remember.empty()) {
+        // The focus observer blocks in XNextEvent while the signal loop switches layouts.
+        XInitThreads();
+        connection = new XkbConnection();
+        auto memory = new active_window_layout_memory(*connection, settings.remember == "class", settings.rememberSize);
+        std::thread layout_memory_thread(active_window_thread, memory);
+        layout_memory_thread.detach();
+    }
     while (1) {
         sigset_t set;
         siginfo_t sinfo;